@@ -0,0 +1,80 @@
+//
+// Created by cyberarm on 2025-07-02.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tiny_gltf.h"
+
+// A single row of the scene inspector, entries are stored in pre-order so that a
+// row's descendants are always the contiguous range [index + 1, subtree_end).
+struct GltfSceneIndexEntry {
+    std::string label;
+    int32_t parent = -1;
+    uint32_t depth = 0;
+    uint32_t subtree_end = 0;
+    bool expanded = false;
+};
+
+// Slots of the names matching one filter
+struct GltfSceneFilterStep {
+    std::string filter;
+    std::vector<uint32_t> matches;
+};
+
+// Flat, prebuilt index of a glTF model for the ImGui inspector.
+// Building the index walks the model once, after that the inspector only touches
+// the rows which are visible (see ImGuiListClipper) and filtering only touches the
+// lowercase name buffer instead of the model.
+class GltfSceneIndex
+{
+private:
+    std::vector<GltfSceneIndexEntry> m_entries = {};
+
+    // Lowercase name index, kept apart from the entries so a filter pass only walks small, packed arrays.
+    // Slot N describes the Nth searchable entry, categories and property rows aren't searchable.
+    std::string m_lowercase_names;
+    std::vector<uint32_t> m_searchable = {};
+    std::vector<uint32_t> m_name_offsets = {};
+    std::vector<uint32_t> m_name_lengths = {};
+    std::vector<uint64_t> m_name_masks = {};
+    std::vector<uint64_t> m_name_pair_masks = {};
+
+    // Rows currently shown, rebuilt lazily when expansion or filter changes
+    std::vector<uint32_t> m_visible_rows = {};
+    bool m_visible_rows_dirty = true;
+
+    // Filter state, one step per filter typed so far where each step's filter extends the previous one.
+    // Typing more characters only re-checks the previous matches, backspacing pops back to a previous step.
+    std::vector<GltfSceneFilterStep> m_filter_steps = {};
+    std::vector<int32_t> m_parents = {};
+    std::vector<uint32_t> m_marked = {};
+    uint32_t m_mark_generation = 0;
+
+    int32_t add_entry(const std::string &label, int32_t parent, bool searchable);
+    int32_t add_category(const char *name, size_t count);
+    void add_nodes(const tinygltf::Model &model, int32_t parent);
+    void finalize();
+    void rebuild_visible_rows();
+
+public:
+    GltfSceneIndex() = default;
+    explicit GltfSceneIndex(const tinygltf::Model &model);
+
+    void rebuild(const tinygltf::Model &model);
+    void set_filter(const std::string &filter);
+
+    const std::vector<uint32_t> &visible_rows();
+    const GltfSceneIndexEntry &entry(uint32_t index) const { return m_entries[index]; }
+    bool has_children(uint32_t index) const { return m_entries[index].subtree_end > index + 1; }
+    bool is_open(uint32_t index) const { return is_filtering() || m_entries[index].expanded; }
+    void set_expanded(uint32_t index, bool expanded);
+
+    bool is_filtering() const { return !m_filter_steps.empty(); }
+    size_t size() const { return m_entries.size(); }
+    size_t match_count() const { return is_filtering() ? m_filter_steps.back().matches.size() : 0; }
+};
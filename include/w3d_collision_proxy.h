@@ -0,0 +1,83 @@
+//
+// Created by cyberarm on 2025-07-04.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "w3d_file.h"
+#include "chunkio.h"
+#include "tiny_gltf.h"
+#include "vector3.h"
+#include "vector3i.h"
+
+// World transform of a glTF node, rotation is an x, y, z, w quaternion
+struct W3dNodeTransform {
+    Vector3 translation = {0.f, 0.f, 0.f};
+    W3dQuaternionStruct rotation = {0.f, 0.f, 0.f, 1.f};
+    Vector3 scale = {1.f, 1.f, 1.f};
+};
+
+// Simplified collision stand-in for a render mesh, either an oriented box (W3D_CHUNK_BOX) or,
+// when the box is a poor fit, a decimated convex hull written out as a hidden collision mesh.
+// One proxy is fitted per mesh and scale, every node instancing it gets its own pivot, see
+// pivot_translation() and pivot_rotation().
+class W3dCollisionProxy
+{
+private:
+    const tinygltf::Model *m_model;
+    int m_mesh;
+    Vector3 m_scale;
+    std::string m_name;
+    std::vector<Vector3> m_points = {};
+
+    // Oriented bounding box, axes are the box's local X/Y/Z in (scaled) mesh space
+    Vector3 m_center = {0.f, 0.f, 0.f};
+    Vector3 m_extent = {0.f, 0.f, 0.f};
+    Vector3 m_axes[3] = {{1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}};
+    bool m_fitted = false;
+
+    // Convex hull, in box space
+    bool m_use_hull = false;
+    std::vector<Vector3> m_hull_vertices = {};
+    std::vector<Vector3i> m_hull_triangles = {};
+
+    void collect_points();
+    void build_box();
+    bool build_hull();
+
+public:
+    // Hull is kept when its volume is below 85% of the box volume
+    static constexpr float HULL_VOLUME_RATIO = 0.85f;
+    // Hulls are built from at most this many points after decimation
+    static constexpr size_t MAX_HULL_POINTS = 96;
+
+    static constexpr uint32_t COLLISION_TYPES =
+            W3D_BOX_ATTRIBTUE_COLLISION_TYPE_PHYSICAL | W3D_BOX_ATTRIBTUE_COLLISION_TYPE_VEHICLE;
+
+    W3dCollisionProxy(const tinygltf::Model &model, int mesh, const Vector3 &scale, const std::string &name);
+
+    // World transform of every node, honouring both matrix and TRS nodes
+    static std::vector<W3dNodeTransform> world_transforms(const tinygltf::Model &model);
+
+    // Heavy lifting, reads the mesh's positions and fits the box/hull. Safe to call from worker
+    // threads as proxies only read the model. Releases the source points once done.
+    void build();
+
+    // Whether the mesh has positions build() can read
+    bool has_points() const;
+    // Whether build() found any points to fit, proxies which aren't must not be written
+    bool is_fitted() const { return m_fitted; }
+    bool uses_hull() const { return m_use_hull; }
+    const std::string &name() const { return m_name; }
+
+    // Pivot placing this proxy at a node instancing it, scale is already baked into the proxy
+    W3dVectorStruct pivot_translation(const W3dNodeTransform &transform) const;
+    W3dQuaternionStruct pivot_rotation(const W3dNodeTransform &transform) const;
+
+    bool write(ChunkSaveClass &writer, const std::string &container_name) const;
+    bool write_box(ChunkSaveClass &writer, const std::string &container_name) const;
+    bool write_hull(ChunkSaveClass &writer, const std::string &container_name) const;
+};
@@ -9,6 +9,13 @@
 #include "tiny_gltf.h"
 
 #include "w3d_pivot.h"
+#include "w3d_collision_proxy.h"
+
+// A node placing a collision proxy, proxies are shared by every node with the same mesh and scale
+struct W3dCollisionInstance {
+    size_t proxy;
+    uint32_t bone_index;
+};
 
 class W3dHierarchyModel
 {
@@ -16,8 +23,11 @@ private:
     tinygltf::Model m_model;
     ChunkSaveClass m_writer;
     bool m_optimize_for_terrain = false;
+    bool m_generate_collision = true;
     std::vector<W3dPivot> m_meshes = {};
     std::vector<W3dPivot> m_pivots = {};
+    std::vector<W3dCollisionProxy> m_collision_proxies = {};
+    std::vector<W3dCollisionInstance> m_collision_instances = {};
     std::unordered_map<std::string, uint8_t> m_proxy_counter = {};
 
     // For showing progress in ImGui
@@ -27,6 +37,7 @@ private:
 
     // Constantly const constants
     // TODO: Make static constants?
+    const std::string m_container_name = "TS_Level"; // FIXME: Get filename/htree name (i.e. Container Name)
     const W3dVectorStruct m_origin = {0.f, 0.f, 0.f};
     const W3dPivotFixupStruct m_identity_matrix = {
             1, 0, 0,
@@ -35,19 +46,22 @@ private:
             0, 0, 0
     };
     public:
-    W3dHierarchyModel(tinygltf::Model model, ChunkSaveClass csave, bool optimize_for_terrain = false);
+    W3dHierarchyModel(tinygltf::Model model, ChunkSaveClass csave, bool optimize_for_terrain = false,
+                      bool generate_collision = true);
     ~W3dHierarchyModel();
 
     bool convert();
     bool add_root_transform();
     bool add_pivots();
     bool add_proxies();
+    bool add_collision_proxies();
 
     bool write();
     bool write_hierarchy_header();
     bool write_pivots();
     bool write_pivot_fixups();
     bool write_meshes();
+    bool write_collision_proxies();
     bool write_hierarchical_level_of_detail();
 
     bool write_mesh(tinygltf::Mesh &mesh) { return false; };
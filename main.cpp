@@ -8,6 +8,7 @@
 #include "w3d_file.h"
 #include "chunkio.h"
 #include "w3d_hierarchy_model.h"
+#include "gltf_scene_index.h"
 
 #include "tiny_gltf.h"
 
@@ -22,12 +23,13 @@
 #define GLTF_FILENAME "D:/W3DHub/games/tiberian-sun-reborn/LevelEdit/TS_Level/ts_level.glb"
 #define W3D_FILENAME "D:/W3DHub/games/tiberian-sun-reborn/LevelEdit/TS_Level/ts_level.w3d"
 
-bool exportW3DHierarchyModel(tinygltf::Model &model, const std::string &filename, bool optimize_for_terrain = false) {
+bool exportW3DHierarchyModel(tinygltf::Model &model, const std::string &filename, bool optimize_for_terrain = false,
+                             bool generate_collision = true) {
     SDL_IOStream *stream = SDL_IOFromFile(filename.c_str(), "wb");
 
     auto m_writer = ChunkSaveClass(stream);
 
-    W3dHierarchyModel(model, m_writer, true);
+    W3dHierarchyModel(model, m_writer, optimize_for_terrain, generate_collision);
 
     SDL_CloseIO(stream);
     return true;
@@ -82,6 +84,9 @@ int main(int, char **) {
         exportW3DHierarchyModel(model, W3D_FILENAME, true);
     }
 
+    // Prebuilt once per loaded model, the GUI never walks the model itself
+    GltfSceneIndex scene_index(model);
+
     // Setup SDL
     // [If using SDL_MAIN_USE_CALLBACKS: all code below until the main loop starts would likely be your SDL_AppInit() function]
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMEPAD)) {
@@ -211,95 +216,45 @@ int main(int, char **) {
             ImGui::Text("DRAG and DROP .gltf or .glb file here");
             ImGui::Text("NOTE: Embedded images will not be used.");
             ImGui::Spacing();
-            ImGui::Text("\nTODO: Show TreeView of GLTF contents here once loaded.");
-
-            if (true)
-            {
-                if (ImGui::TreeNodeEx("Model", ImGuiTreeNodeFlags_DefaultOpen)) {
-                    // SCENES
-                    if (ImGui::TreeNode("tinygltf_scenes", "Scenes - %d", model.scenes.size())) {
-                        for (const auto &scene: model.scenes) {
-                            if (ImGui::TreeNode(scene.name.c_str())) {
-                                ImGui::TreePop();
-                            }
-                        }
-                        ImGui::TreePop();
-                    }
-
-                    // NODES
-                    if (ImGui::TreeNode("tinygltf_nodes", "Nodes/Objects - %d", model.nodes.size())) {
-                        for (const auto &node: model.nodes) {
-                            if (ImGui::TreeNode(node.name.c_str())) {
-                                ImGui::TreePop();
-                            }
-                        }
-                        ImGui::TreePop();
-                    }
-
-                    // MESHES
-                    if (ImGui::TreeNode("tinygltf_meshes", "Meshes - %d", model.meshes.size())) {
-                        for (const auto &mesh: model.meshes) {
-                            if (ImGui::TreeNode(mesh.name.c_str())) {
-                                ImGui::TreePop();
-                            }
-                        }
-                        ImGui::TreePop();
-                    }
-
-                    // IMAGES
-                    if (ImGui::TreeNode("tinygltf_images", "Images - %d", model.images.size())) {
-                        for (const auto &image: model.images) {
-                            if (ImGui::TreeNode(image.name.c_str())) {
-                                ImGui::TreePop();
-                            }
-                        }
-                        ImGui::TreePop();
-                    }
-
-                    // TEXTURES
-                    if (ImGui::TreeNode("tinygltf_textures", "Textures - %d", model.textures.size())) {
-                        for (const auto &texture: model.textures) {
-                            if (ImGui::TreeNode(texture.name.c_str())) {
-                                ImGui::TreePop();
-                            }
-                        }
-                        ImGui::TreePop();
-                    }
-
-                    // MATERIALS
-                    if (ImGui::TreeNode("tinygltf_materials", "Materials - %d", model.materials.size())) {
-                        for (const auto &material: model.materials) {
-                            if (ImGui::TreeNode(material.name.c_str())) {
-                                ImGui::Text("Double Sided: %s", material.doubleSided ? "True" : "False");
-
-                                ImGui::TreePop();
-                            }
-                        }
-                        ImGui::TreePop();
-                    }
-
-                    // CAMERAS
-                    if (ImGui::TreeNode("tinygltf_cameras", "Cameras - %d", model.cameras.size())) {
-                        for (const auto &camera: model.cameras) {
-                            if (ImGui::TreeNode(camera.name.c_str())) {
-                                ImGui::TreePop();
-                            }
-                        }
-                        ImGui::TreePop();
-                    }
 
-                    // LIGHTS
-                    if (ImGui::TreeNode("tinygltf_lights", "Lights - %d", model.lights.size())) {
-                        for (const auto &light: model.lights) {
-                            if (ImGui::TreeNode(light.name.c_str())) {
-                                ImGui::TreePop();
-                            }
-                        }
-                        ImGui::TreePop();
+            // Model TreeView, only the rows on screen are submitted so huge levels stay responsive
+            static char filter_buf[128] = "";
+            ImGui::SetNextItemWidth(-FLT_MIN);
+            if (ImGui::InputTextWithHint("##scene_filter", "Filter by name", filter_buf, IM_ARRAYSIZE(filter_buf)))
+                scene_index.set_filter(filter_buf);
+            if (scene_index.is_filtering())
+                ImGui::Text("%zu matches", scene_index.match_count());
+
+            if (ImGui::BeginChild("scene_tree", {0, 0}, ImGuiChildFlags_Borders)) {
+                const auto &rows = scene_index.visible_rows();
+                const float indent_spacing = style.IndentSpacing;
+
+                ImGuiListClipper clipper;
+                clipper.Begin(static_cast<int>(rows.size()));
+                while (clipper.Step()) {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                        const uint32_t index = rows[row];
+                        const auto &entry = scene_index.entry(index);
+                        const bool has_children = scene_index.has_children(index);
+
+                        ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_SpanAvailWidth;
+                        if (!has_children)
+                            flags |= ImGuiTreeNodeFlags_Leaf;
+                        else
+                            ImGui::SetNextItemOpen(scene_index.is_open(index));
+
+                        ImGui::SetCursorPosX(ImGui::GetCursorPosX() + entry.depth * indent_spacing);
+                        ImGui::PushID(static_cast<int>(index));
+                        bool open = ImGui::TreeNodeEx("##entry", flags, "%s", entry.label.c_str());
+                        ImGui::PopID();
+
+                        // Only marks the rows dirty, they're rebuilt on the next frame
+                        if (has_children)
+                            scene_index.set_expanded(index, open);
                     }
-                    ImGui::TreePop();
                 }
             }
+            ImGui::EndChild();
 
             ImGui::TableNextColumn();
             ImGui::Text("W3D Export Options");
@@ -312,6 +267,11 @@ int main(int, char **) {
             ImGui::Combo("W3D Type", &listbox_item_current, listbox_items, 2);
             static bool opt_terrain = false;
             ImGui::Checkbox("Optimize for Terrain", &opt_terrain);
+            static bool opt_collision = true;
+            // Collision proxies are skipped for terrain, see W3dHierarchyModel::add_pivots()
+            ImGui::BeginDisabled(opt_terrain);
+            ImGui::Checkbox("Generate Collision Proxies", &opt_collision);
+            ImGui::EndDisabled();
 
             // Export Button
             // NOTE: We manually move imgui's 'cursor' so it MUST be the last element of the 'window' created
@@ -321,7 +281,8 @@ int main(int, char **) {
             ImGui::SetCursorPosY(ImGui::GetCursorPosY() + ImGui::GetContentRegionAvail().y - button_height);
             ImGui::ProgressBar(0.25f, {ImGui::GetContentRegionAvail().x - (button_width + style.ItemSpacing.x), 0});
             ImGui::SameLine();
-            ImGui::Button("Export", {button_width, 0});
+            if (ImGui::Button("Export", {button_width, 0}))
+                exportW3DHierarchyModel(model, W3D_FILENAME, opt_terrain, opt_collision);
             ImGui::EndTable();
 
             ImGui::End();
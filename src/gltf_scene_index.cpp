@@ -0,0 +1,325 @@
+//
+// Created by cyberarm on 2025-07-02.
+//
+
+#include "gltf_scene_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+
+static std::string to_lower(const std::string &string) {
+    std::string lower = string;
+    for (auto &c : lower)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+    return lower;
+}
+
+// Which characters appear in a (lowercase) name, letters, digits and '_' get a bit of their own.
+// A name can only contain the filter if its mask covers the filter's mask.
+static uint64_t character_mask(std::string_view string) {
+    uint64_t mask = 0;
+    for (unsigned char c : string) {
+        if (c >= 'a' && c <= 'z')
+            mask |= 1ull << (c - 'a');
+        else if (c >= '0' && c <= '9')
+            mask |= 1ull << (26 + c - '0');
+        else if (c == '_')
+            mask |= 1ull << 36;
+        else
+            mask |= 1ull << (37 + c % 27);
+    }
+
+    return mask;
+}
+
+// Hashed set of the adjacent character pairs in a (lowercase) name, much more selective than
+// character_mask() once the filter is two or more characters long.
+static uint64_t pair_mask(std::string_view string) {
+    uint64_t mask = 0;
+    for (size_t i = 1; i < string.size(); i++) {
+        const unsigned char a = string[i - 1];
+        const unsigned char b = string[i];
+        mask |= 1ull << ((a * 31u + b) % 64);
+    }
+
+    return mask;
+}
+
+static bool has_own_mask_bit(unsigned char c) {
+    return std::isalnum(c) || c == '_';
+}
+
+static std::string label_or_fallback(const std::string &name, const char *kind, size_t index) {
+    if (!name.empty())
+        return name;
+
+    return std::string("<unnamed ") + kind + " #" + std::to_string(index) + ">";
+}
+
+GltfSceneIndex::GltfSceneIndex(const tinygltf::Model &model) {
+    rebuild(model);
+}
+
+void GltfSceneIndex::rebuild(const tinygltf::Model &model) {
+    m_entries.clear();
+    m_lowercase_names.clear();
+    m_searchable.clear();
+    m_name_offsets.clear();
+    m_name_lengths.clear();
+    m_name_masks.clear();
+    m_name_pair_masks.clear();
+    m_filter_steps.clear();
+
+    // SCENES
+    int32_t category = add_category("Scenes", model.scenes.size());
+    for (size_t i = 0; i < model.scenes.size(); i++)
+        add_entry(label_or_fallback(model.scenes[i].name, "scene", i), category, true);
+
+    // NODES, shown with their real parent/child hierarchy
+    category = add_category("Nodes/Objects", model.nodes.size());
+    add_nodes(model, category);
+
+    // MESHES
+    category = add_category("Meshes", model.meshes.size());
+    for (size_t i = 0; i < model.meshes.size(); i++)
+        add_entry(label_or_fallback(model.meshes[i].name, "mesh", i), category, true);
+
+    // IMAGES
+    category = add_category("Images", model.images.size());
+    for (size_t i = 0; i < model.images.size(); i++)
+        add_entry(label_or_fallback(model.images[i].name, "image", i), category, true);
+
+    // TEXTURES
+    category = add_category("Textures", model.textures.size());
+    for (size_t i = 0; i < model.textures.size(); i++)
+        add_entry(label_or_fallback(model.textures[i].name, "texture", i), category, true);
+
+    // MATERIALS
+    category = add_category("Materials", model.materials.size());
+    for (size_t i = 0; i < model.materials.size(); i++) {
+        const auto &material = model.materials[i];
+        int32_t parent = add_entry(label_or_fallback(material.name, "material", i), category, true);
+        add_entry(std::string("Double Sided: ") + (material.doubleSided ? "True" : "False"), parent, false);
+    }
+
+    // CAMERAS
+    category = add_category("Cameras", model.cameras.size());
+    for (size_t i = 0; i < model.cameras.size(); i++)
+        add_entry(label_or_fallback(model.cameras[i].name, "camera", i), category, true);
+
+    // LIGHTS
+    category = add_category("Lights", model.lights.size());
+    for (size_t i = 0; i < model.lights.size(); i++)
+        add_entry(label_or_fallback(model.lights[i].name, "light", i), category, true);
+
+    finalize();
+}
+
+int32_t GltfSceneIndex::add_entry(const std::string &label, int32_t parent, bool searchable) {
+    GltfSceneIndexEntry entry = {};
+    entry.label = label;
+    entry.parent = parent;
+    entry.depth = parent < 0 ? 0 : m_entries[parent].depth + 1;
+
+    if (searchable) {
+        const std::string lower = to_lower(label);
+        m_searchable.emplace_back(static_cast<uint32_t>(m_entries.size()));
+        m_name_offsets.emplace_back(static_cast<uint32_t>(m_lowercase_names.size()));
+        m_name_lengths.emplace_back(static_cast<uint32_t>(lower.size()));
+        m_name_masks.emplace_back(character_mask(lower));
+        m_name_pair_masks.emplace_back(pair_mask(lower));
+        m_lowercase_names += lower;
+    }
+
+    m_entries.emplace_back(entry);
+
+    return static_cast<int32_t>(m_entries.size() - 1);
+}
+
+int32_t GltfSceneIndex::add_category(const char *name, size_t count) {
+    return add_entry(std::string(name) + " - " + std::to_string(count), -1, false);
+}
+
+void GltfSceneIndex::add_nodes(const tinygltf::Model &model, int32_t parent) {
+    const size_t node_count = model.nodes.size();
+
+    // Nodes which aren't a child of any other node are roots
+    std::vector<bool> has_parent(node_count, false);
+    for (const auto &node : model.nodes) {
+        for (int child : node.children) {
+            if (child >= 0 && static_cast<size_t>(child) < node_count)
+                has_parent[child] = true;
+        }
+    }
+
+    // Iterative pre-order walk, levels can be deep enough to blow the stack when recursing.
+    // Each stack item is a node index and the entry index of its parent.
+    std::vector<std::pair<int, int32_t>> stack;
+    std::vector<bool> visited(node_count, false);
+
+    auto walk = [&](int root) {
+        stack.emplace_back(root, parent);
+
+        while (!stack.empty()) {
+            auto [node_index, parent_entry] = stack.back();
+            stack.pop_back();
+
+            // Malformed files may share nodes, only list each node once
+            if (visited[node_index])
+                continue;
+            visited[node_index] = true;
+
+            const auto &node = model.nodes[node_index];
+            int32_t entry = add_entry(label_or_fallback(node.name, "node", node_index), parent_entry, true);
+
+            for (size_t i = node.children.size(); i-- > 0;) {
+                int child = node.children[i];
+                if (child >= 0 && static_cast<size_t>(child) < node_count && !visited[child])
+                    stack.emplace_back(child, entry);
+            }
+        }
+    };
+
+    for (size_t i = 0; i < node_count; i++) {
+        if (!has_parent[i])
+            walk(static_cast<int>(i));
+    }
+
+    // Nodes in a pure cycle have no root leading to them, list them as roots of their own
+    for (size_t i = 0; i < node_count; i++) {
+        if (!visited[i])
+            walk(static_cast<int>(i));
+    }
+}
+
+void GltfSceneIndex::finalize() {
+    // Entries are in pre-order, so walking backwards lets every entry extend its parent's subtree
+    for (size_t i = 0; i < m_entries.size(); i++)
+        m_entries[i].subtree_end = static_cast<uint32_t>(i + 1);
+
+    for (size_t i = m_entries.size(); i-- > 0;) {
+        int32_t parent = m_entries[i].parent;
+        if (parent >= 0)
+            m_entries[parent].subtree_end = std::max(m_entries[parent].subtree_end, m_entries[i].subtree_end);
+    }
+
+    m_parents.clear();
+    for (const auto &entry : m_entries)
+        m_parents.emplace_back(entry.parent);
+
+    m_marked.assign(m_entries.size(), 0);
+    m_mark_generation = 0;
+    m_visible_rows.reserve(m_entries.size());
+    m_visible_rows_dirty = true;
+}
+
+void GltfSceneIndex::set_filter(const std::string &filter) {
+    const std::string needle = to_lower(filter);
+    if (is_filtering() ? needle == m_filter_steps.back().filter : needle.empty())
+        return;
+
+    // Backspacing or replacing the filter, drop the steps which don't lead to it
+    while (!m_filter_steps.empty() && !needle.starts_with(m_filter_steps.back().filter))
+        m_filter_steps.pop_back();
+
+    m_visible_rows_dirty = true;
+    if (needle.empty() || (is_filtering() && needle == m_filter_steps.back().filter))
+        return;
+
+    const char *names = m_lowercase_names.data();
+    const uint64_t needle_mask = character_mask(needle);
+    const uint64_t needle_pair_mask = pair_mask(needle);
+    // A single character with a mask bit of its own is decided by the mask alone
+    const bool mask_is_exact = needle.size() == 1 && has_own_mask_bit(needle[0]);
+
+    auto matches = [&](uint32_t slot) {
+        if ((m_name_masks[slot] & needle_mask) != needle_mask ||
+            (m_name_pair_masks[slot] & needle_pair_mask) != needle_pair_mask)
+            return false;
+
+        const std::string_view name(names + m_name_offsets[slot], m_name_lengths[slot]);
+        return mask_is_exact || name.find(needle) != std::string_view::npos;
+    };
+
+    GltfSceneFilterStep step = {needle};
+    if (is_filtering()) {
+        // Narrowing the filter, only previous matches can still match
+        const std::vector<uint32_t> &previous = m_filter_steps.back().matches;
+        step.matches.reserve(previous.size());
+        for (uint32_t slot : previous) {
+            if (matches(slot))
+                step.matches.emplace_back(slot);
+        }
+    }
+    else {
+        for (uint32_t slot = 0; slot < m_searchable.size(); slot++) {
+            if (matches(slot))
+                step.matches.emplace_back(slot);
+        }
+    }
+
+    m_filter_steps.emplace_back(std::move(step));
+}
+
+const std::vector<uint32_t> &GltfSceneIndex::visible_rows() {
+    if (m_visible_rows_dirty)
+        rebuild_visible_rows();
+
+    return m_visible_rows;
+}
+
+void GltfSceneIndex::set_expanded(uint32_t index, bool expanded) {
+    // Everything is forced open while filtering
+    if (is_filtering() || m_entries[index].expanded == expanded)
+        return;
+
+    m_entries[index].expanded = expanded;
+    m_visible_rows_dirty = true;
+}
+
+void GltfSceneIndex::rebuild_visible_rows() {
+    m_visible_rows.clear();
+    m_visible_rows_dirty = false;
+
+    if (!is_filtering()) {
+        // Skip over the subtree of collapsed entries
+        uint32_t i = 0;
+        while (i < m_entries.size()) {
+            m_visible_rows.emplace_back(i);
+            i = m_entries[i].expanded ? i + 1 : m_entries[i].subtree_end;
+        }
+
+        return;
+    }
+
+    // Show matches along with their ancestors so that they keep their place in the hierarchy.
+    // Matches are in pre-order, so ancestors which aren't shown yet come after every row shown so far
+    // and appending each chain (collected bottom up, hence reversed) keeps the rows sorted.
+    // Marks are generation stamps so they never need to be cleared.
+    if (++m_mark_generation == 0) {
+        m_marked.assign(m_marked.size(), 0);
+        m_mark_generation = 1;
+    }
+
+    for (uint32_t slot : m_filter_steps.back().matches) {
+        const int32_t row = static_cast<int32_t>(m_searchable[slot]);
+        const int32_t parent = m_parents[row];
+
+        // Usually a sibling of the previous match, shown already
+        if (parent < 0 || m_marked[parent] == m_mark_generation) {
+            m_marked[row] = m_mark_generation;
+            m_visible_rows.emplace_back(row);
+            continue;
+        }
+
+        const size_t chain_start = m_visible_rows.size();
+        for (int32_t i = row; i >= 0 && m_marked[i] != m_mark_generation; i = m_parents[i]) {
+            m_marked[i] = m_mark_generation;
+            m_visible_rows.emplace_back(i);
+        }
+
+        std::reverse(m_visible_rows.begin() + chain_start, m_visible_rows.end());
+    }
+}
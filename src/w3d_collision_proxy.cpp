@@ -0,0 +1,809 @@
+//
+// Created by cyberarm on 2025-07-04.
+//
+
+#include "w3d_collision_proxy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <unordered_map>
+
+// Rotate vector by an x, y, z, w quaternion
+static Vector3 rotate(const W3dQuaternionStruct &q, const Vector3 &v) {
+    const Vector3 u(q.Q[0], q.Q[1], q.Q[2]);
+    const float w = q.Q[3];
+    const Vector3 t = 2.f * Vector3::Cross_Product(u, v);
+
+    return v + w * t + Vector3::Cross_Product(u, t);
+}
+
+static W3dQuaternionStruct multiply(const W3dQuaternionStruct &a, const W3dQuaternionStruct &b) {
+    return {
+            a.Q[3] * b.Q[0] + a.Q[0] * b.Q[3] + a.Q[1] * b.Q[2] - a.Q[2] * b.Q[1],
+            a.Q[3] * b.Q[1] - a.Q[0] * b.Q[2] + a.Q[1] * b.Q[3] + a.Q[2] * b.Q[0],
+            a.Q[3] * b.Q[2] + a.Q[0] * b.Q[1] - a.Q[1] * b.Q[0] + a.Q[2] * b.Q[3],
+            a.Q[3] * b.Q[3] - a.Q[0] * b.Q[0] - a.Q[1] * b.Q[1] - a.Q[2] * b.Q[2]
+    };
+}
+
+// Quaternion for the rotation matrix whose columns are axes
+static W3dQuaternionStruct quaternion_from_axes(const Vector3 axes[3]) {
+    const float m00 = axes[0].X, m01 = axes[1].X, m02 = axes[2].X;
+    const float m10 = axes[0].Y, m11 = axes[1].Y, m12 = axes[2].Y;
+    const float m20 = axes[0].Z, m21 = axes[1].Z, m22 = axes[2].Z;
+
+    W3dQuaternionStruct q = {};
+    const float trace = m00 + m11 + m22;
+    if (trace > 0.f) {
+        float s = std::sqrt(trace + 1.f) * 2.f;
+        q.Q[3] = 0.25f * s;
+        q.Q[0] = (m21 - m12) / s;
+        q.Q[1] = (m02 - m20) / s;
+        q.Q[2] = (m10 - m01) / s;
+    }
+    else if (m00 > m11 && m00 > m22) {
+        float s = std::sqrt(1.f + m00 - m11 - m22) * 2.f;
+        q.Q[3] = (m21 - m12) / s;
+        q.Q[0] = 0.25f * s;
+        q.Q[1] = (m01 + m10) / s;
+        q.Q[2] = (m02 + m20) / s;
+    }
+    else if (m11 > m22) {
+        float s = std::sqrt(1.f + m11 - m00 - m22) * 2.f;
+        q.Q[3] = (m02 - m20) / s;
+        q.Q[0] = (m01 + m10) / s;
+        q.Q[1] = 0.25f * s;
+        q.Q[2] = (m12 + m21) / s;
+    }
+    else {
+        float s = std::sqrt(1.f + m22 - m00 - m11) * 2.f;
+        q.Q[3] = (m10 - m01) / s;
+        q.Q[0] = (m02 + m20) / s;
+        q.Q[1] = (m12 + m21) / s;
+        q.Q[2] = 0.25f * s;
+    }
+
+    return q;
+}
+
+// Eigenvectors of a symmetric 3x3 matrix using Jacobi rotations, returned as columns of vectors
+static void symmetric_eigenvectors(float a[3][3], float vectors[3][3]) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++)
+            vectors[i][j] = i == j ? 1.f : 0.f;
+    }
+
+    for (int sweep = 0; sweep < 32; sweep++) {
+        float off_diagonal = std::fabs(a[0][1]) + std::fabs(a[0][2]) + std::fabs(a[1][2]);
+        if (off_diagonal < 1e-9f)
+            break;
+
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                if (std::fabs(a[p][q]) < 1e-12f)
+                    continue;
+
+                float theta = (a[q][q] - a[p][p]) / (2.f * a[p][q]);
+                float t = (theta >= 0.f ? 1.f : -1.f) / (std::fabs(theta) + std::sqrt(theta * theta + 1.f));
+                float c = 1.f / std::sqrt(t * t + 1.f);
+                float s = t * c;
+
+                for (int k = 0; k < 3; k++) {
+                    float akp = a[k][p];
+                    float akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; k++) {
+                    float apk = a[p][k];
+                    float aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; k++) {
+                    float vkp = vectors[k][p];
+                    float vkq = vectors[k][q];
+                    vectors[k][p] = c * vkp - s * vkq;
+                    vectors[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+// Double precision vector for the hull, Vector3 is float only
+struct HullVector {
+    double x, y, z;
+};
+
+static HullVector operator-(const HullVector &a, const HullVector &b) {
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+static HullVector operator*(const HullVector &a, double k) {
+    return {a.x * k, a.y * k, a.z * k};
+}
+
+static double dot(const HullVector &a, const HullVector &b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static HullVector cross(const HullVector &a, const HullVector &b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+// Local matrix of a node, column-major like glTF, either given directly or composed as T * R * S
+static void local_matrix(const tinygltf::Node &node, double m[16]) {
+    if (node.matrix.size() == 16) {
+        for (int i = 0; i < 16; i++)
+            m[i] = node.matrix[i];
+
+        return;
+    }
+
+    const double tx = node.translation.size() == 3 ? node.translation[0] : 0.0;
+    const double ty = node.translation.size() == 3 ? node.translation[1] : 0.0;
+    const double tz = node.translation.size() == 3 ? node.translation[2] : 0.0;
+    const double x = node.rotation.size() == 4 ? node.rotation[0] : 0.0;
+    const double y = node.rotation.size() == 4 ? node.rotation[1] : 0.0;
+    const double z = node.rotation.size() == 4 ? node.rotation[2] : 0.0;
+    const double w = node.rotation.size() == 4 ? node.rotation[3] : 1.0;
+    const double sx = node.scale.size() == 3 ? node.scale[0] : 1.0;
+    const double sy = node.scale.size() == 3 ? node.scale[1] : 1.0;
+    const double sz = node.scale.size() == 3 ? node.scale[2] : 1.0;
+
+    const double rotation[16] = {
+            1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0,
+            2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0,
+            2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0,
+            0, 0, 0, 1
+    };
+
+    for (int i = 0; i < 4; i++) {
+        m[i] = rotation[i] * sx;
+        m[4 + i] = rotation[4 + i] * sy;
+        m[8 + i] = rotation[8 + i] * sz;
+    }
+    m[12] = tx;
+    m[13] = ty;
+    m[14] = tz;
+    m[15] = 1.0;
+}
+
+static void multiply(const double a[16], const double b[16], double result[16]) {
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            double sum = 0.0;
+            for (int k = 0; k < 4; k++)
+                sum += a[k * 4 + row] * b[column * 4 + k];
+            result[column * 4 + row] = sum;
+        }
+    }
+}
+
+// Split a world matrix into translation, rotation and (signed) scale, shear is dropped
+static W3dNodeTransform decompose(const double m[16]) {
+    W3dNodeTransform transform;
+    transform.translation.Set(m[12], m[13], m[14]);
+
+    Vector3 axes[3];
+    for (int i = 0; i < 3; i++) {
+        axes[i].Set(m[i * 4], m[i * 4 + 1], m[i * 4 + 2]);
+        transform.scale[i] = axes[i].Length();
+    }
+
+    // Mirrored, flip one axis so the rest is a proper rotation
+    if (Vector3::Dot_Product(Vector3::Cross_Product(axes[0], axes[1]), axes[2]) < 0.f) {
+        transform.scale.X = -transform.scale.X;
+        axes[0] = -axes[0];
+    }
+
+    if (transform.scale.X == 0.f || transform.scale.Y == 0.f || transform.scale.Z == 0.f)
+        return transform;
+
+    axes[0].Normalize();
+    axes[1] -= axes[0] * (axes[0] * axes[1]);
+    axes[1].Normalize();
+    axes[2] = Vector3::Cross_Product(axes[0], axes[1]);
+    transform.rotation = quaternion_from_axes(axes);
+
+    return transform;
+}
+
+std::vector<W3dNodeTransform> W3dCollisionProxy::world_transforms(const tinygltf::Model &model) {
+    const size_t node_count = model.nodes.size();
+    std::vector<W3dNodeTransform> transforms(node_count);
+
+    std::vector<bool> has_parent(node_count, false);
+    for (const auto &node : model.nodes) {
+        for (int child : node.children) {
+            if (child >= 0 && static_cast<size_t>(child) < node_count)
+                has_parent[child] = true;
+        }
+    }
+
+    // Iterative walk from the roots carrying the parent's world matrix, each node is visited once
+    // so malformed files with shared or cyclic children can't loop forever.
+    struct Item {
+        int node;
+        double parent[16];
+    };
+    std::vector<Item> stack;
+    std::vector<bool> visited(node_count, false);
+    const double identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    auto walk = [&](int root) {
+        Item item = {root};
+        memcpy(item.parent, identity, sizeof(identity));
+        stack.emplace_back(item);
+
+        while (!stack.empty()) {
+            item = stack.back();
+            stack.pop_back();
+
+            if (visited[item.node])
+                continue;
+            visited[item.node] = true;
+
+            const auto &node = model.nodes[item.node];
+            double local[16];
+            double world[16];
+            local_matrix(node, local);
+            multiply(item.parent, local, world);
+            transforms[item.node] = decompose(world);
+
+            for (int child : node.children) {
+                if (child < 0 || static_cast<size_t>(child) >= node_count || visited[child])
+                    continue;
+
+                Item child_item = {child};
+                memcpy(child_item.parent, world, sizeof(world));
+                stack.emplace_back(child_item);
+            }
+        }
+    };
+
+    for (size_t i = 0; i < node_count; i++) {
+        if (!has_parent[i])
+            walk(static_cast<int>(i));
+    }
+    for (size_t i = 0; i < node_count; i++) {
+        if (!visited[i])
+            walk(static_cast<int>(i));
+    }
+
+    return transforms;
+}
+
+W3dCollisionProxy::W3dCollisionProxy(const tinygltf::Model &model, int mesh, const Vector3 &scale,
+                                     const std::string &name) :
+        m_model(&model),
+        m_mesh(mesh),
+        m_scale(scale),
+        m_name(name) {}
+
+// POSITION accessor of a primitive if collect_points() can read it: dense float VEC3 data lying
+// within its buffer view and buffer. Other layouts are valid glTF (e.g. KHR_mesh_quantization)
+// but unsupported for now, and tinygltf doesn't validate accessor ranges.
+static const tinygltf::Accessor *readable_positions(const tinygltf::Model &model,
+                                                    const tinygltf::Primitive &primitive) {
+    auto attribute = primitive.attributes.find("POSITION");
+    if (attribute == primitive.attributes.end() || attribute->second < 0 ||
+        static_cast<size_t>(attribute->second) >= model.accessors.size())
+        return nullptr;
+
+    const auto &accessor = model.accessors[attribute->second];
+    if (accessor.count == 0 || accessor.sparse.isSparse || accessor.type != TINYGLTF_TYPE_VEC3 ||
+        accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || accessor.bufferView < 0 ||
+        static_cast<size_t>(accessor.bufferView) >= model.bufferViews.size())
+        return nullptr;
+
+    const auto &buffer_view = model.bufferViews[accessor.bufferView];
+    if (buffer_view.buffer < 0 || static_cast<size_t>(buffer_view.buffer) >= model.buffers.size())
+        return nullptr;
+
+    const int stride = accessor.ByteStride(buffer_view);
+    const size_t buffer_size = model.buffers[buffer_view.buffer].data.size();
+    if (stride <= 0 || buffer_view.byteOffset > buffer_size ||
+        buffer_view.byteLength > buffer_size - buffer_view.byteOffset)
+        return nullptr;
+
+    // Last element must end within the view, written to not overflow on huge counts
+    const size_t element_size = 3 * sizeof(float);
+    if (accessor.byteOffset > buffer_view.byteLength ||
+        buffer_view.byteLength - accessor.byteOffset < element_size ||
+        accessor.count - 1 > (buffer_view.byteLength - accessor.byteOffset - element_size) / stride)
+        return nullptr;
+
+    return &accessor;
+}
+
+bool W3dCollisionProxy::has_points() const {
+    for (const auto &primitive : m_model->meshes[m_mesh].primitives) {
+        if (readable_positions(*m_model, primitive))
+            return true;
+    }
+
+    return false;
+}
+
+void W3dCollisionProxy::collect_points() {
+    // Collect vertex positions of every primitive, scale is baked in since pivots can't carry it
+    for (const auto &primitive : m_model->meshes[m_mesh].primitives) {
+        const tinygltf::Accessor *accessor = readable_positions(*m_model, primitive);
+        if (!accessor)
+            continue;
+
+        const auto &buffer_view = m_model->bufferViews[accessor->bufferView];
+        const auto &buffer = m_model->buffers[buffer_view.buffer];
+        const int stride = accessor->ByteStride(buffer_view);
+
+        const unsigned char *data = buffer.data.data() + buffer_view.byteOffset + accessor->byteOffset;
+        m_points.reserve(m_points.size() + accessor->count);
+        for (size_t i = 0; i < accessor->count; i++) {
+            float position[3];
+            memcpy(position, data + i * stride, sizeof(position));
+            m_points.emplace_back(position[0] * m_scale.X, position[1] * m_scale.Y, position[2] * m_scale.Z);
+        }
+    }
+}
+
+void W3dCollisionProxy::build() {
+    collect_points();
+    if (m_points.empty())
+        return;
+
+    build_box();
+    m_fitted = true;
+
+    const float box_volume = 8.f * m_extent.X * m_extent.Y * m_extent.Z;
+    m_use_hull = build_hull();
+    if (m_use_hull) {
+        // Volume of the hull, summed tetrahedrons from the box center
+        float hull_volume = 0.f;
+        for (const auto &triangle : m_hull_triangles) {
+            const Vector3 &a = m_hull_vertices[triangle.I];
+            const Vector3 &b = m_hull_vertices[triangle.J];
+            const Vector3 &c = m_hull_vertices[triangle.K];
+            hull_volume += a * Vector3::Cross_Product(b, c) / 6.f;
+        }
+
+        // Box fits well enough, boxes are by far the cheapest to collide with
+        if (hull_volume >= box_volume * HULL_VOLUME_RATIO) {
+            m_use_hull = false;
+            m_hull_vertices.clear();
+            m_hull_triangles.clear();
+        }
+    }
+
+    // Source points are no longer needed, meshes can be huge
+    m_points.clear();
+    m_points.shrink_to_fit();
+}
+
+void W3dCollisionProxy::build_box() {
+    // Principal axes of the point cloud
+    Vector3 mean(0.f, 0.f, 0.f);
+    for (const auto &point : m_points)
+        mean += point;
+    mean /= static_cast<float>(m_points.size());
+
+    float covariance[3][3] = {};
+    for (const auto &point : m_points) {
+        const Vector3 d = point - mean;
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++)
+                covariance[i][j] += d[i] * d[j];
+        }
+    }
+
+    float vectors[3][3];
+    symmetric_eigenvectors(covariance, vectors);
+
+    Vector3 principal_axes[3];
+    for (int i = 0; i < 3; i++) {
+        principal_axes[i].Set(vectors[0][i], vectors[1][i], vectors[2][i]);
+        principal_axes[i].Normalize();
+    }
+    principal_axes[2] = Vector3::Cross_Product(principal_axes[0], principal_axes[1]);
+    principal_axes[2].Normalize();
+
+    // Principal axes aren't always the tightest fit (e.g. boxy props), keep the smaller of them and the AABB
+    const Vector3 node_axes[3] = {{1.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}};
+    float best_volume = -1.f;
+    for (const Vector3 *axes : std::initializer_list<const Vector3 *>{principal_axes, node_axes}) {
+        Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+        Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (const auto &point : m_points) {
+            for (int i = 0; i < 3; i++) {
+                float d = point * axes[i];
+                min[i] = std::min(min[i], d);
+                max[i] = std::max(max[i], d);
+            }
+        }
+
+        const Vector3 extent = (max - min) * 0.5f;
+        const float volume = extent.X * extent.Y * extent.Z;
+        if (best_volume >= 0.f && volume >= best_volume)
+            continue;
+
+        best_volume = volume;
+        m_extent = extent;
+        const Vector3 local_center = (max + min) * 0.5f;
+        m_center = axes[0] * local_center.X + axes[1] * local_center.Y + axes[2] * local_center.Z;
+        for (int i = 0; i < 3; i++)
+            m_axes[i] = axes[i];
+    }
+}
+
+bool W3dCollisionProxy::build_hull() {
+    const float size = std::max({m_extent.X, m_extent.Y, m_extent.Z});
+    if (size <= 0.f || std::min({m_extent.X, m_extent.Y, m_extent.Z}) <= size * 1e-3f)
+        return false; // Flat, the box is as good as it gets
+
+    // Decimate by clustering on a grid in box space, keeping the point of each cell furthest
+    // from the center so that the hull doesn't shrink much.
+    std::vector<Vector3> points;
+    for (int resolution : {8, 6, 5, 4, 3}) {
+        std::unordered_map<int, Vector3> cells;
+        for (const auto &point : m_points) {
+            const Vector3 d = point - m_center;
+            const Vector3 local(d * m_axes[0], d * m_axes[1], d * m_axes[2]);
+
+            int cell = 0;
+            for (int i = 0; i < 3; i++) {
+                int c = static_cast<int>((local[i] + m_extent[i]) / (2.f * m_extent[i]) * resolution);
+                cell = cell * resolution + std::clamp(c, 0, resolution - 1);
+            }
+
+            auto [it, inserted] = cells.try_emplace(cell, local);
+            if (!inserted && local.Length2() > it->second.Length2())
+                it->second = local;
+        }
+
+        points.clear();
+        for (const auto &[cell, point] : cells)
+            points.emplace_back(point);
+
+        if (points.size() <= MAX_HULL_POINTS)
+            break;
+    }
+
+    if (points.size() < 4)
+        return false;
+
+    // Quickhull, every face keeps the points in front of it (its conflict list) and the point
+    // furthest out is added first. Points within epsilon of the hull are dropped as coplanar.
+    struct Face {
+        int v[3];
+        HullVector normal;
+        double dist;
+        bool alive;
+        int visited;
+        std::vector<int> outside;
+    };
+
+    // Built in double precision with a tight epsilon, a loose one lets faces kept as "coplanar"
+    // add up to visibly concave edges. Input is float, so the result is checked at float precision.
+    std::vector<HullVector> hull_points;
+    hull_points.reserve(points.size());
+    for (const auto &point : points)
+        hull_points.push_back({point.X, point.Y, point.Z});
+
+    const double epsilon = size * 1e-9;
+    const double tolerance = size * 1e-5;
+    std::vector<Face> faces;
+    // Directed edge -> face owning it, a closed hull has every edge's reverse owned by its neighbor
+    std::map<std::pair<int, int>, int> edge_faces;
+    bool broken = false;
+
+    auto distance = [&](const Face &face, int point) {
+        return dot(face.normal, hull_points[point]) - face.dist;
+    };
+
+    auto add_face = [&](int a, int b, int c) {
+        Face face = {{a, b, c}, {}, 0.0, true, -1, {}};
+        face.normal = cross(hull_points[b] - hull_points[a], hull_points[c] - hull_points[a]);
+        const double length = std::sqrt(dot(face.normal, face.normal));
+        if (length <= epsilon * epsilon)
+            broken = true; // Sliver, can't be trusted to have a sane normal
+        else
+            face.normal = face.normal * (1.0 / length);
+        face.dist = dot(face.normal, hull_points[a]);
+
+        const int index = static_cast<int>(faces.size());
+        for (int e = 0; e < 3; e++) {
+            if (!edge_faces.emplace(std::make_pair(face.v[e], face.v[(e + 1) % 3]), index).second)
+                broken = true;
+        }
+        faces.emplace_back(std::move(face));
+
+        return index;
+    };
+
+    auto remove_face = [&](Face &face) {
+        face.alive = false;
+        for (int e = 0; e < 3; e++)
+            edge_faces.erase({face.v[e], face.v[(e + 1) % 3]});
+    };
+
+    // Hand point to the face it's furthest in front of, points behind every face are inside
+    auto assign_point = [&](int point, const std::vector<int> &candidates) {
+        int best_face = -1;
+        double best_distance = epsilon;
+        for (int candidate : candidates) {
+            double d = distance(faces[candidate], point);
+            if (d > best_distance) {
+                best_distance = d;
+                best_face = candidate;
+            }
+        }
+        if (best_face >= 0)
+            faces[best_face].outside.emplace_back(point);
+    };
+
+    // Initial tetrahedron from extreme, non-degenerate points
+    int i0 = 0, i1 = -1, i2 = -1, i3 = -1;
+    double best = 0.0;
+    for (int i = 1; i < static_cast<int>(points.size()); i++) {
+        const HullVector d = hull_points[i] - hull_points[i0];
+        if (dot(d, d) > best) {
+            best = dot(d, d);
+            i1 = i;
+        }
+    }
+    best = 0.0;
+    for (int i = 0; i < static_cast<int>(points.size()) && i1 >= 0; i++) {
+        const HullVector n = cross(hull_points[i1] - hull_points[i0], hull_points[i] - hull_points[i0]);
+        if (dot(n, n) > best) {
+            best = dot(n, n);
+            i2 = i;
+        }
+    }
+    best = 0.0;
+    double side = 0.0;
+    for (int i = 0; i < static_cast<int>(points.size()) && i2 >= 0; i++) {
+        HullVector normal = cross(hull_points[i1] - hull_points[i0], hull_points[i2] - hull_points[i0]);
+        normal = normal * (1.0 / std::sqrt(dot(normal, normal)));
+        double d = dot(normal, hull_points[i] - hull_points[i0]);
+        if (std::fabs(d) > best) {
+            best = std::fabs(d);
+            side = d;
+            i3 = i;
+        }
+    }
+    if (i3 < 0 || best <= tolerance)
+        return false;
+
+    // Wind the faces outwards, i3 is above the i0-i1-i2 plane when side is positive
+    if (side > 0.0)
+        std::swap(i1, i2);
+    add_face(i0, i1, i2);
+    add_face(i0, i3, i1);
+    add_face(i1, i3, i2);
+    add_face(i2, i3, i0);
+
+    const std::vector<int> initial_faces = {0, 1, 2, 3};
+    for (int p = 0; p < static_cast<int>(points.size()); p++) {
+        if (p != i0 && p != i1 && p != i2 && p != i3)
+            assign_point(p, initial_faces);
+    }
+
+    for (int iteration = 0; !broken; iteration++) {
+        int face_index = -1;
+        for (int i = 0; i < static_cast<int>(faces.size()); i++) {
+            if (faces[i].alive && !faces[i].outside.empty()) {
+                face_index = i;
+                break;
+            }
+        }
+        if (face_index < 0)
+            break;
+
+        int eye = faces[face_index].outside.front();
+        for (int point : faces[face_index].outside) {
+            if (distance(faces[face_index], point) > distance(faces[face_index], eye))
+                eye = point;
+        }
+
+        // Grow the visible region from the face so that it is connected and has a single horizon
+        std::vector<int> visible = {face_index};
+        std::vector<std::pair<int, int>> horizon;
+        faces[face_index].visited = iteration;
+        for (size_t v = 0; v < visible.size() && !broken; v++) {
+            const Face &face = faces[visible[v]];
+            for (int e = 0; e < 3; e++) {
+                const int a = face.v[e];
+                const int b = face.v[(e + 1) % 3];
+                auto neighbor = edge_faces.find({b, a});
+                if (neighbor == edge_faces.end()) {
+                    broken = true;
+                    break;
+                }
+
+                Face &other = faces[neighbor->second];
+                if (other.visited == iteration)
+                    continue;
+
+                if (distance(other, eye) > epsilon) {
+                    other.visited = iteration;
+                    visible.emplace_back(neighbor->second);
+                }
+                else {
+                    horizon.emplace_back(a, b);
+                }
+            }
+        }
+        if (broken)
+            break;
+
+        std::vector<int> orphans;
+        for (int index : visible) {
+            for (int point : faces[index].outside) {
+                if (point != eye)
+                    orphans.emplace_back(point);
+            }
+            faces[index].outside.clear();
+            remove_face(faces[index]);
+        }
+
+        std::vector<int> new_faces;
+        for (const auto &[a, b] : horizon)
+            new_faces.emplace_back(add_face(a, b, eye));
+
+        for (int point : orphans)
+            assign_point(point, new_faces);
+    }
+
+    std::erase_if(faces, [](const Face &face) { return !face.alive; });
+
+    // Reject anything that isn't a closed, convex hull, the box is still a safe fallback
+    if (broken || faces.size() < 4 || edge_faces.size() != faces.size() * 3)
+        return false;
+    for (const auto &[edge, face] : edge_faces) {
+        if (!edge_faces.contains({edge.second, edge.first}))
+            return false;
+    }
+    for (const auto &face : faces) {
+        for (int e = 0; e < 3; e++) {
+            for (const auto &other : faces) {
+                if (distance(other, face.v[e]) > tolerance)
+                    return false;
+            }
+        }
+    }
+
+    // Compact into the used vertices only
+    std::vector<int> remap(points.size(), -1);
+    for (const auto &face : faces) {
+        Vector3i triangle;
+        for (int i = 0; i < 3; i++) {
+            int &index = remap[face.v[i]];
+            if (index < 0) {
+                index = static_cast<int>(m_hull_vertices.size());
+                m_hull_vertices.emplace_back(points[face.v[i]]);
+            }
+            triangle[i] = index;
+        }
+        m_hull_triangles.emplace_back(triangle);
+    }
+
+    return !m_hull_triangles.empty();
+}
+
+W3dVectorStruct W3dCollisionProxy::pivot_translation(const W3dNodeTransform &transform) const {
+    const Vector3 translation = transform.translation + rotate(transform.rotation, m_center);
+
+    return {translation.X, translation.Y, translation.Z};
+}
+
+W3dQuaternionStruct W3dCollisionProxy::pivot_rotation(const W3dNodeTransform &transform) const {
+    return multiply(transform.rotation, quaternion_from_axes(m_axes));
+}
+
+bool W3dCollisionProxy::write(ChunkSaveClass &writer, const std::string &container_name) const {
+    return m_use_hull ? write_hull(writer, container_name) : write_box(writer, container_name);
+}
+
+bool W3dCollisionProxy::write_box(ChunkSaveClass &writer, const std::string &container_name) const {
+    W3dBoxStruct box = {};
+    box.Version = W3D_BOX_CURRENT_VERSION;
+    box.Attributes = W3D_BOX_ATTRIBUTE_ORIENTED | COLLISION_TYPES;
+    snprintf(box.Name, sizeof(box.Name), "%s.%s", container_name.c_str(), m_name.c_str());
+    box.Color = W3dRGBStruct(0, 255, 0);
+    box.Center = {0.f, 0.f, 0.f};
+    box.Extent = {m_extent.X, m_extent.Y, m_extent.Z};
+
+    writer.begin_chunk(W3D_CHUNK_BOX);
+    writer.write(&box, sizeof(W3dBoxStruct));
+    writer.end_chunk();
+
+    return true;
+}
+
+bool W3dCollisionProxy::write_hull(ChunkSaveClass &writer, const std::string &container_name) const {
+    // Smooth normals, hidden collision meshes are never lit but the loader expects them
+    std::vector<Vector3> normals(m_hull_vertices.size(), Vector3(0.f, 0.f, 0.f));
+    std::vector<W3dTriStruct> triangles;
+    triangles.reserve(m_hull_triangles.size());
+    for (const auto &triangle : m_hull_triangles) {
+        const Vector3 &a = m_hull_vertices[triangle.I];
+        Vector3 normal = Vector3::Cross_Product(m_hull_vertices[triangle.J] - a, m_hull_vertices[triangle.K] - a);
+        normal.Normalize();
+
+        W3dTriStruct tri = {};
+        for (int i = 0; i < 3; i++) {
+            tri.Vindex[i] = triangle[i];
+            normals[triangle[i]] += normal;
+        }
+        tri.Normal = {normal.X, normal.Y, normal.Z};
+        tri.Dist = normal * a;
+        triangles.emplace_back(tri);
+    }
+
+    Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+    Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (const auto &vertex : m_hull_vertices) {
+        min.Update_Min(vertex);
+        max.Update_Max(vertex);
+    }
+
+    W3dMeshHeader3Struct header = {};
+    header.Version = W3D_CURRENT_MESH_VERSION;
+    header.Attributes = W3D_MESH_FLAG_HIDDEN | W3D_MESH_FLAG_GEOMETRY_TYPE_NORMAL |
+                        W3D_MESH_FLAG_COLLISION_TYPE_PHYSICAL | W3D_MESH_FLAG_COLLISION_TYPE_VEHICLE;
+    strncpy(header.MeshName, m_name.c_str(), W3D_NAME_LEN - 1);
+    strncpy(header.ContainerName, container_name.c_str(), W3D_NAME_LEN - 1);
+    header.NumTris = static_cast<uint32_t>(triangles.size());
+    header.NumVertices = static_cast<uint32_t>(m_hull_vertices.size());
+    header.SortLevel = SORT_LEVEL_NONE;
+    header.VertexChannels = W3D_VERTEX_CHANNEL_LOCATION | W3D_VERTEX_CHANNEL_NORMAL;
+    header.FaceChannels = W3D_FACE_CHANNEL_FACE;
+    header.Min = {min.X, min.Y, min.Z};
+    header.Max = {max.X, max.Y, max.Z};
+    const Vector3 sphere_center = (min + max) * 0.5f;
+    header.SphCenter = {sphere_center.X, sphere_center.Y, sphere_center.Z};
+    header.SphRadius = 0.f;
+    for (const auto &vertex : m_hull_vertices)
+        header.SphRadius = std::max(header.SphRadius, (vertex - sphere_center).Length());
+
+    writer.begin_chunk(W3D_CHUNK_MESH);
+
+    writer.begin_chunk(W3D_CHUNK_MESH_HEADER3);
+    writer.write(&header, sizeof(W3dMeshHeader3Struct));
+    writer.end_chunk();
+
+    writer.begin_chunk(W3D_CHUNK_VERTICES);
+    for (const auto &vertex : m_hull_vertices)
+        writer.write(W3dVectorStruct{vertex.X, vertex.Y, vertex.Z});
+    writer.end_chunk();
+
+    writer.begin_chunk(W3D_CHUNK_VERTEX_NORMALS);
+    for (auto normal : normals) {
+        normal.Normalize();
+        writer.write(W3dVectorStruct{normal.X, normal.Y, normal.Z});
+    }
+    writer.end_chunk();
+
+    writer.begin_chunk(W3D_CHUNK_TRIANGLES);
+    writer.write(triangles.data(), static_cast<uint32_t>(triangles.size() * sizeof(W3dTriStruct)));
+    writer.end_chunk();
+
+    writer.begin_chunk(W3D_CHUNK_VERTEX_SHADE_INDICES);
+    for (uint32_t i = 0; i < m_hull_vertices.size(); i++)
+        writer.write(&i, sizeof(uint32_t));
+    writer.end_chunk();
+
+    // No material passes, collision only
+    W3dMaterialInfoStruct material_info = {};
+    writer.begin_chunk(W3D_CHUNK_MATERIAL_INFO);
+    writer.write(&material_info, sizeof(W3dMaterialInfoStruct));
+    writer.end_chunk();
+
+    writer.end_chunk(); // W3D_CHUNK_MESH
+
+    return true;
+}
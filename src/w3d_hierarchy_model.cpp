@@ -4,15 +4,27 @@
 
 #include "w3d_hierarchy_model.h"
 
-W3dHierarchyModel::W3dHierarchyModel(tinygltf::Model model, ChunkSaveClass writer, bool optimize_for_terrain) :
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <thread>
+#include <tuple>
+
+W3dHierarchyModel::W3dHierarchyModel(tinygltf::Model model, ChunkSaveClass writer, bool optimize_for_terrain,
+                                     bool generate_collision) :
         m_model(model),
         m_writer(writer),
-        m_optimize_for_terrain(optimize_for_terrain) {
+        m_optimize_for_terrain(optimize_for_terrain),
+        m_generate_collision(generate_collision) {
     // Collect Meshes
     //      Collect Vertices (Position, UV, etc.)
     //      Collect Materials
     //      Collect Axis Aligned Bounding Box(es)
     // Collect Proxies
+    // Collect Collision Proxies (Boxes/Convex Hulls)
     convert();
 
     // Write out file
@@ -45,6 +57,10 @@ bool W3dHierarchyModel::add_root_transform() {
 bool W3dHierarchyModel::add_pivots() {
     add_proxies();
 
+    // Terrain collides with its own render mesh
+    if (m_generate_collision && !m_optimize_for_terrain)
+        add_collision_proxies();
+
     return true;
 }
 
@@ -81,6 +97,107 @@ bool W3dHierarchyModel::add_proxies() {
     return true;
 }
 
+bool W3dHierarchyModel::add_collision_proxies() {
+    const std::vector<W3dNodeTransform> transforms = W3dCollisionProxy::world_transforms(m_model);
+
+    // Meshes are commonly instanced, fit each mesh once per distinct scale. Scales are rounded
+    // so that float noise from matrix decomposition doesn't split otherwise identical instances.
+    std::map<std::tuple<int, int64_t, int64_t, int64_t>, size_t> shapes;
+    std::vector<std::pair<size_t, size_t>> instances; // node, proxy
+
+    for (size_t i = 0; i < m_model.nodes.size(); i++)
+    {
+        const tinygltf::Node &node = m_model.nodes[i];
+        if (node.mesh < 0)
+            continue;
+
+        // Proxies/placeholders don't collide
+        const tinygltf::Mesh &mesh = m_model.meshes.at(node.mesh);
+        if (mesh.name.find('~') != std::string::npos)
+            continue;
+
+        const Vector3 &scale = transforms[i].scale;
+        auto key = std::make_tuple(node.mesh, std::llround(scale.X * 1e4), std::llround(scale.Y * 1e4),
+                                   std::llround(scale.Z * 1e4));
+
+        auto shape = shapes.find(key);
+        if (shape == shapes.end())
+        {
+            std::string suffix = "_" + std::to_string(m_collision_proxies.size());
+            std::string name = mesh.name.substr(0, W3D_NAME_LEN - 1 - suffix.size()) + suffix;
+
+            W3dCollisionProxy proxy(m_model, node.mesh, scale, name);
+            if (!proxy.has_points())
+                continue;
+
+            shape = shapes.emplace(key, m_collision_proxies.size()).first;
+            m_collision_proxies.emplace_back(std::move(proxy));
+        }
+
+        instances.emplace_back(i, shape->second);
+    }
+
+    // Fitting boxes and hulls is independent per shape, spread it over all cores
+    std::atomic<size_t> next_proxy = 0;
+    auto worker = [&]() {
+        for (size_t i = next_proxy++; i < m_collision_proxies.size(); i = next_proxy++)
+            m_collision_proxies[i].build();
+    };
+
+    std::vector<std::thread> workers;
+    const size_t worker_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                 m_collision_proxies.size());
+    for (size_t i = 0; i < worker_count; i++)
+        workers.emplace_back(worker);
+    for (auto &thread : workers)
+        thread.join();
+
+    // Drop proxies which ended up with nothing to fit, along with their instances
+    std::vector<size_t> remap(m_collision_proxies.size(), SIZE_MAX);
+    size_t fitted = 0;
+    for (size_t i = 0; i < m_collision_proxies.size(); i++)
+    {
+        if (!m_collision_proxies[i].is_fitted())
+            continue;
+
+        remap[i] = fitted;
+        if (fitted != i)
+            m_collision_proxies[fitted] = std::move(m_collision_proxies[i]);
+        fitted++;
+    }
+    m_collision_proxies.erase(m_collision_proxies.begin() + fitted, m_collision_proxies.end());
+
+    for (auto [node_index, proxy_index] : instances)
+    {
+        if (remap[proxy_index] == SIZE_MAX)
+            continue;
+        proxy_index = remap[proxy_index];
+
+        const W3dCollisionProxy &proxy = m_collision_proxies[proxy_index];
+        const W3dNodeTransform &transform = transforms[node_index];
+        const std::string &node_name = m_model.nodes[node_index].name;
+        const std::string &base_name = node_name.empty() ? proxy.name() : node_name;
+
+        // Node index keeps pivot names unique between instances
+        std::string suffix = "_" + std::to_string(node_index);
+        std::string name = base_name.substr(0, W3D_NAME_LEN - 1 - suffix.size()) + suffix;
+
+        W3dPivotStruct pivot = {};
+
+        strcpy(pivot.Name, name.c_str());
+        pivot.ParentIdx = 0;
+        pivot.Translation = proxy.pivot_translation(transform);
+        pivot.EulerAngles = m_origin;
+        pivot.Rotation = proxy.pivot_rotation(transform);
+
+        m_collision_instances.emplace_back(
+                W3dCollisionInstance{proxy_index, static_cast<uint32_t>(m_pivots.size())});
+        m_pivots.emplace_back(W3dPivot{pivot, false});
+    }
+
+    return true;
+}
+
 bool W3dHierarchyModel::write() {
     m_writer.begin_chunk(W3D_CHUNK_HIERARCHY);
     write_hierarchy_header();
@@ -89,6 +206,7 @@ bool W3dHierarchyModel::write() {
     m_writer.end_chunk();
 
     write_meshes();
+    write_collision_proxies();
     write_hierarchical_level_of_detail();
 
     return true;
@@ -97,11 +215,13 @@ bool W3dHierarchyModel::write() {
 bool W3dHierarchyModel::write_hierarchy_header() {
     W3dHierarchyStruct header = {
             W3D_CURRENT_HTREE_VERSION,
-            "TS_Level", // FIXME: Get filename/htree name (i.e. Container Name)
+            {},
             static_cast<uint32_t>(m_pivots.size()),
             m_origin
     };
 
+    strncpy(header.Name, m_container_name.c_str(), W3D_NAME_LEN - 1);
+
     m_writer.begin_chunk(W3D_CHUNK_HIERARCHY_HEADER);
     m_writer.write(&header, sizeof(W3dHierarchyStruct));
     m_writer.end_chunk();
@@ -144,23 +264,56 @@ bool W3dHierarchyModel::write_meshes() {
     return true;
 }
 
+bool W3dHierarchyModel::write_collision_proxies() {
+    for (const auto &proxy : m_collision_proxies)
+        proxy.write(m_writer, m_container_name);
+
+    return true;
+}
+
 bool W3dHierarchyModel::write_hierarchical_level_of_detail() {
     W3dHLodHeaderStruct header {
         W3D_CURRENT_HLOD_VERSION,
         1,
-        "ts_level",
-        "ts_level"
+        {},
+        {}
     };
+    strncpy(header.Name, m_container_name.c_str(), W3D_NAME_LEN - 1);
+    strncpy(header.HierarchyName, m_container_name.c_str(), W3D_NAME_LEN - 1);
 
     m_writer.begin_chunk(W3D_CHUNK_HLOD);
     m_writer.begin_chunk(W3D_CHUNK_HLOD_HEADER);
     m_writer.write(&header, sizeof(W3dHLodHeaderStruct));
     m_writer.end_chunk();
 
+    // Collision proxies are the only render objects of the (single) LOD for now, one per instance
+    m_writer.begin_chunk(W3D_CHUNK_HLOD_LOD_ARRAY);
+    m_writer.begin_chunk(W3D_CHUNK_HLOD_SUB_OBJECT_ARRAY_HEADER);
+    W3dHLodArrayHeaderStruct lod_array_header = {
+            static_cast<uint32_t>(m_collision_instances.size()),
+            NO_MAX_SCREEN_SIZE
+    };
+    m_writer.write(&lod_array_header, sizeof(W3dHLodArrayHeaderStruct));
+    m_writer.end_chunk();
+
+    for (const auto &instance : m_collision_instances)
+    {
+        W3dHLodSubObjectStruct hlod_subobject_struct {};
+        hlod_subobject_struct.BoneIndex = instance.bone_index;
+        snprintf(hlod_subobject_struct.Name, sizeof(hlod_subobject_struct.Name), "%s.%s",
+                 m_container_name.c_str(), m_collision_proxies[instance.proxy].name().c_str());
+
+        m_writer.begin_chunk(W3D_CHUNK_HLOD_SUB_OBJECT);
+        m_writer.write(&hlod_subobject_struct, sizeof(W3dHLodSubObjectStruct));
+        m_writer.end_chunk();
+    }
+    m_writer.end_chunk(); // W3D_CHUNK_HLOD_LOD_ARRAY
+
     m_writer.begin_chunk(W3D_CHUNK_HLOD_PROXY_ARRAY);
     m_writer.begin_chunk(W3D_CHUNK_HLOD_SUB_OBJECT_ARRAY_HEADER);
     W3dHLodArrayHeaderStruct hlod_array_header = {
-            static_cast<uint32_t>(m_pivots.size() - 1),
+            static_cast<uint32_t>(std::count_if(m_pivots.begin(), m_pivots.end(),
+                                                [](W3dPivot &piv) { return piv.is_proxy(); })),
             0
     };
     m_writer.write(&hlod_array_header, sizeof(W3dHLodArrayHeaderStruct));